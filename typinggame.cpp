@@ -1,4 +1,4 @@
-// build: g++ typinggame.cpp -o game -lncurses
+// build: g++ -std=c++17 typinggame.cpp -o game -lncurses
 // run: game < input.txt
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +15,17 @@
 #endif
 #include <time.h>
 #include <assert.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <errno.h>
+#include <memory>
 
 using namespace std;
 
@@ -73,40 +84,167 @@ char* findword(char* buff, char delim, int& num_spaces)
    return &(ptr[start]);
 }
 
+//------------------------
+//   sprites
+//------------------------
+// Sprites are tables of equal length rows. Their dimensions and the runs of
+// non-blank characters (spans) are computed at compile time, and a sprite with
+// ragged rows fails to compile. Drawing only touches the spans.
+
+struct Span
+{
+   int row = 0;
+   int start = 0;
+   int len = 0;
+};
+
+constexpr int rowWidth(const char* row)
+{
+   int len = 0;
+   while (row[len] != '\0') len++;
+   return len;
+}
+
+// finds the runs where the cell is opaque in 'rows' and, if 'prev' is given,
+// was not opaque in 'prev' (used to clear what the previous frame left behind)
+template <int H, int W>
+constexpr int findSpans(const char* const* rows, const char* const* prev, Span* spans)
+{
+   int num = 0;
+   for (int i = 0; i < H; i++)
+   {
+      int j = 0;
+      while (j < W)
+      {
+         bool on = prev ? (prev[i][j] != ' ' && rows[i][j] == ' ') : rows[i][j] != ' ';
+         if (!on) { j++; continue; }
+         int start = j;
+         while (j < W && (prev ? (prev[i][j] != ' ' && rows[i][j] == ' ') : rows[i][j] != ' ')) j++;
+         spans[num++] = Span{i, start, j - start};
+      }
+   }
+   return num;
+}
+
+// draws spans of 'rows' at p clipped to the screen; erase writes blanks instead
+inline void drawSpans(const Span* spans, int num, const char* const* rows, const Vec2& p, bool erase)
+{
+   for (int k = 0; k < num; k++)
+   {
+      const Span& s = spans[k];
+      int x = p.x + s.row;
+      if (x < 0 || x >= LINES) continue;
+      int y = p.y + s.start;
+      int skip = y < 0 ? -y : 0;
+      int len = min(s.len - skip, COLS - (y + skip));
+      if (len <= 0) continue;
+      if (erase) mvhline(x, y + skip, ' ', len);
+      else mvaddnstr(x, y + skip, rows[s.row] + s.start + skip, len);
+   }
+}
+
+template <int H, int W>
+struct Sprite
+{
+   static constexpr int height = H;
+   static constexpr int width = W;
+   static constexpr int MAX_SPANS = H * ((W + 1) / 2);
+
+   constexpr Sprite(const char* const (&_rows)[H]) : rows(_rows), spans(), numSpans(0)
+   {
+      for (int i = 0; i < H; i++)
+      {
+         if (rowWidth(_rows[i]) != W) throw "sprite has ragged rows";
+      }
+      numSpans = findSpans<H, W>(rows, nullptr, spans);
+   }
+
+   Vec2 dim() const { return Vec2(H, W); }
+   void draw(const Vec2& p) const { drawSpans(spans, numSpans, rows, p, false); }
+   void erase(const Vec2& p) const { drawSpans(spans, numSpans, rows, p, true); }
+
+   const char* const* rows;
+   Span spans[MAX_SPANS];
+   int numSpans;
+};
+
+// Frames of the same size. Drawing frame f also clears the cells that frame
+// f-1 drew and frame f leaves blank.
+template <int N, int H, int W>
+struct Animation
+{
+   static constexpr int numFrames = N;
+
+   template <class... Rows>
+   constexpr Animation(const Rows&... _frames) : frames{Sprite<H, W>(_frames)...}, clear(), numClear()
+   {
+      for (int f = 1; f < N; f++)
+      {
+         numClear[f] = findSpans<H, W>(frames[f].rows, frames[f-1].rows, clear[f]);
+      }
+   }
+
+   Vec2 dim() const { return Vec2(H, W); }
+
+   void draw(int f, const Vec2& p) const
+   {
+      drawSpans(clear[f], numClear[f], frames[f].rows, p, true);
+      frames[f].draw(p);
+   }
+
+   Sprite<H, W> frames[N];
+   Span clear[N][Sprite<H, W>::MAX_SPANS];
+   int numClear[N];
+};
+
+template <const auto& ROWS>
+constexpr auto makeSprite()
+{
+   constexpr int H = sizeof(ROWS) / sizeof(ROWS[0]);
+   static_assert(H > 0, "sprite has no rows");
+   return Sprite<H, rowWidth(ROWS[0])>(ROWS);
+}
+
+template <const auto& FIRST, const auto&... REST>
+constexpr auto makeAnimation()
+{
+   constexpr int H = sizeof(FIRST) / sizeof(FIRST[0]);
+   static_assert(((sizeof(REST) / sizeof(REST[0]) == H) && ...), "animation frames differ in height");
+   return Animation<1 + sizeof...(REST), H, rowWidth(FIRST[0])>(FIRST, REST...);
+}
+
 //------------------------
 //   graphics
 //------------------------
 const int gNumTrail = 4;
 const char* gTrail = ".*oO";
 
-const int gNumExplosionFade = 4;
-const Vec2 gDimExplosion(3,5);
-const char* gExplosion1[] = {
+constexpr const char* gExplosion1[] = {
 " % % ",
 "% % %",
 " % % "};
-const char* gExplosion2[] = {
+constexpr const char* gExplosion2[] = {
 " * * ",
 "* * *",
 " * * "};
-const char* gExplosion3[] = {
+constexpr const char* gExplosion3[] = {
 " . . ",
 ". . .",
 " . . "};
-const char* gExplosion4[] = {
+constexpr const char* gExplosion4[] = {
 "     ",
 "     ",
 "     "};
+constexpr auto gExplosion = makeAnimation<gExplosion1, gExplosion2, gExplosion3, gExplosion4>();
 
-const Vec2 gDimBeeSprite(4,8); 
-const char* gBeeSprite[] = {
+constexpr const char* gBeeRows[] = {
 "   __   ",
 "  (__\\_ ",
 "-{{_{|8)",
 "  (__/  "};
+constexpr auto gBeeSprite = makeSprite<gBeeRows>();
 
-const Vec2 gDimSky(11,52);
-const char* gSkySprite[] = {
+constexpr const char* gSkyRows[] = {
 "           __----_                                  ",
 "          (`......)                    _            ",
 "         (. _^ ^_ .)                :(`...)`        ",
@@ -118,29 +256,144 @@ const char* gSkySprite[] = {
 "            --'                         :(.. ^ ^ .))",
 "                                       `(....)V .)) ",
 "                                         ...        "};      
+// the sky is only used for its size, ragged row check and rows: it is drawn
+// and tested for collisions as plain rows (see TypingGame::tileSky), not spans
+constexpr auto gSkySprite = makeSprite<gSkyRows>();
 
 const int gFlair[15] = {0,-1,-1,-1,-1,-1,-1,0,1,1,1,1,1,0,0};
 const int gNumFlair = 15; 
 
+//---------------------------------
+// random numbers
+//---------------------------------
+// the game keeps its own generator state so snapshots can restore it
+unsigned int gRandState = 1;
+
+int gameRand()
+{
+   return rand_r(&gRandState);
+}
+
+//---------------------------------
+// snapshots
+//---------------------------------
+// A snapshot is the raw game state in native byte order: a header followed
+// by fields written in the order the classes save them. Hosts that share a
+// snapshot must have the same architecture.
+const char gSnapshotMagic[4] = {'T', 'G', 'S', 'S'};
+const uint32_t gSnapshotVersion = 1;
+
+class SnapshotWriter
+{
+public:
+   template <class T>
+   void put(const T& v)
+   {
+      const char* p = reinterpret_cast<const char*>(&v);
+      mBuf.insert(mBuf.end(), p, p + sizeof(T));
+   }
+
+   void put(const Vec2& v) { put(v.x); put(v.y); }
+
+   void put(const string& str)
+   {
+      put((uint32_t) str.size());
+      mBuf.insert(mBuf.end(), str.begin(), str.end());
+   }
+
+   template <class C>
+   void putAll(const C& values)
+   {
+      put((uint32_t) values.size());
+      for (typename C::const_iterator it = values.begin(); it != values.end(); ++it) put(*it);
+   }
+
+   const vector<char>& buffer() const { return mBuf; }
+
+private:
+   vector<char> mBuf;
+};
+
+class SnapshotReader
+{
+public:
+   SnapshotReader(const char* data, size_t size) : mPtr(data), mEnd(data + size) {}
+
+   template <class T>
+   void get(T& v)
+   {
+      need(sizeof(T));
+      memcpy(&v, mPtr, sizeof(T));
+      mPtr += sizeof(T);
+   }
+
+   void get(Vec2& v) { get(v.x); get(v.y); }
+
+   void get(string& str)
+   {
+      uint32_t len;
+      get(len);
+      need(len);
+      str.assign(mPtr, len);
+      mPtr += len;
+   }
+
+   template <class C>
+   void getAll(C& values)
+   {
+      uint32_t num;
+      get(num);
+      values.resize(num);
+      for (typename C::iterator it = values.begin(); it != values.end(); ++it) get(*it);
+   }
+
+   bool done() const { return mPtr == mEnd; }
+
+private:
+   void need(size_t n)
+   {
+      if (mEnd - mPtr < n) throw runtime_error("snapshot is truncated");
+   }
+
+   const char* mPtr;
+   const char* mEnd;
+};
+
 //---------------------------------
 // game
 //---------------------------------
 class TypingGame
 {
 public:
-   TypingGame()
+   // nullRenderer: draw into a curses screen whose output goes to /dev/null
+   // (used by the bots so many games can run without a terminal)
+   TypingGame(bool nullRenderer = false) : mScreen(0), mNullOut(0), mNullIn(0)
    {
-      init();
+      init(nullRenderer);
    }
 
    ~TypingGame()
    {
       endwin();
+      if (mScreen) delscreen(mScreen);
+      if (mNullOut) fclose(mNullOut);
+      if (mNullIn) fclose(mNullIn);
    }
 
-   void init()
+   void init(bool nullRenderer = false)
    {
-      initscr();
+      if (nullRenderer)
+      {
+         mNullOut = fopen("/dev/null", "w");
+         mNullIn = fopen("/dev/null", "r");
+         if (mNullOut) mScreen = newterm("xterm", mNullOut, mNullIn);
+         if (!mScreen) throw runtime_error("cannot create null screen");
+      }
+      else
+      {
+         initscr();
+      }
+
       if(has_colors() == FALSE) 
       {
          endwin();
@@ -154,6 +407,25 @@ public:
       curs_set(2);
       bkgdset(COLOR_BLACK); // set background color to black
 
+      initColors();
+
+      mScore = 0;
+      mElapsedTime = 0;
+      // NOTE: Need to init text BEFORE loading text!!
+      mTxt.init(this, Vec2(-3,0), textStart());
+      mBee.init(Vec2(0,10), Vec2(gSkySprite.height + SCREEN_START + 2, -gBeeSprite.width), RB_3);
+      mBeeSpawn = 0;
+      mExplosions.init();
+      move(0, 0); addstr("Press ESC to exit.\n");
+      tileSky();
+      drawSky();
+
+
+   }
+
+   // also used by broadcast viewers so they show the same colors
+   static void initColors()
+   {
       start_color();
 	   init_pair(WS_INPROGRESS, COLOR_MAGENTA, COLOR_BLACK);
 	   init_pair(WS_ERROR, COLOR_RED, COLOR_BLACK);
@@ -163,31 +435,29 @@ public:
       init_pair(RB_4, COLOR_GREEN, COLOR_BLACK);
       init_pair(RB_5, COLOR_BLUE, COLOR_BLACK);
       init_pair(RB_6, COLOR_CYAN, COLOR_BLACK);
+   }
 
-      mScore = 0;
-      mElapsedTime = 0;
-      // NOTE: Need to init text BEFORE loading text!!
-      mTxt.init(this, Vec2(-3,0), Vec2(LINES, ((int) COLS*0.5) - 19)); // hard-coded for injust.txt
-      mBee.init(Vec2(0,10), Vec2(gDimSky.x + SCREEN_START + 2, -gDimBeeSprite.y), RB_3);
-      mBeeSpawn = 0;
-      mExplosions.init();
-      move(0, 0); addstr("Press ESC to exit.\n");
-      drawSky(gDimSky, gSkySprite);      
-
-
+   // call on KEY_RESIZE, after curses has updated LINES and COLS
+   // only the sky and the words on screen are laid out again; hidden words
+   // pick up the new start position when they spawn
+   void resize()
+   {
+      tileSky();
+      mTxt.relayout(textStart());
+      drawSky();
    }
 
-   bool loadFile(const string& filename)
+   bool loadFile(const string& filename, float startTime = 0)
    {
       ifstream textfile(filename.c_str());
       if (textfile.is_open())
       {
-         float time = 0;
+         float time = startTime;
          string line;
          while (getline(textfile, line))
          {
             addLine(line, time);
-            time += MIN_TIME_OFFSET + rand() % VAR_TIME_OFFSET; // next text appears between 3 and 8 seconds later
+            time += MIN_TIME_OFFSET + gameRand() % VAR_TIME_OFFSET; // next text appears between 3 and 8 seconds later
          }
          textfile.close();
          return true;
@@ -195,27 +465,120 @@ public:
       return false;
    }
 
+   bool saveSnapshot(const string& filename) const
+   {
+      SnapshotWriter out;
+      out.put(gSnapshotMagic);
+      out.put(gSnapshotVersion);
+      out.put(mScore);
+      out.put(mElapsedTime);
+      out.put(mBeeSpawn);
+      out.put(gRandState);
+      mTxt.save(out);
+      mExplosions.save(out);
+      mBee.save(out);
+
+      // write a temporary file and rename it so a crash never leaves half a snapshot
+      string tmp = filename + ".tmp";
+      int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0) return false;
+      const vector<char>& buf = out.buffer();
+      bool ok = write(fd, buf.data(), buf.size()) == (ssize_t) buf.size();
+      ok = close(fd) == 0 && ok;
+      if (ok) ok = rename(tmp.c_str(), filename.c_str()) == 0;
+      if (!ok) unlink(tmp.c_str());
+      return ok;
+   }
+
+   // returns false and leaves the game unchanged if the file is missing or
+   // is not a valid snapshot
+   bool loadSnapshot(const string& filename)
+   {
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      void* data = MAP_FAILED;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+         data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      close(fd);
+      if (data == MAP_FAILED) return false;
+
+      bool ok = true;
+      try
+      {
+         SnapshotReader in((const char*) data, st.st_size);
+         char magic[4];
+         uint32_t version;
+         in.get(magic);
+         in.get(version);
+         if (memcmp(magic, gSnapshotMagic, 4) != 0 || version != gSnapshotVersion)
+         {
+            throw runtime_error("not a snapshot");
+         }
+
+         int score;
+         float elapsedTime, beeSpawn;
+         unsigned int randState;
+         ScrollText txt = mTxt;
+         Explosions explosions;
+         Bee bee;
+         in.get(score);
+         in.get(elapsedTime);
+         in.get(beeSpawn);
+         in.get(randState);
+         txt.restore(in);
+         explosions.restore(in);
+         bee.restore(in);
+         if (!in.done()) throw runtime_error("snapshot has trailing data");
+
+         mScore = score;
+         mElapsedTime = elapsedTime;
+         mBeeSpawn = beeSpawn;
+         gRandState = randState;
+         mTxt = txt;
+         mExplosions = explosions;
+         mBee = bee;
+      }
+      catch (exception& e)
+      {
+         ok = false;
+      }
+      munmap(data, st.st_size);
+
+      if (ok) // the snapshot may come from a different screen size
+      {
+         erase();
+         move(0, 0); addstr("Press ESC to exit.\n");
+         resize();
+      }
+      return ok;
+   }
+
    void addLine(const string& line, float spawnTime)
    {
       mTxt.addLine(line, spawnTime);
    }
 
-   void drawSky(const Vec2& dim, const char* sprite[])
+   void tileSky() // repeat the sky sprite across the screen width
    {
-      int ypos = 0;
-      while (ypos < COLS)
+      mSky.assign(gSkySprite.height, string());
+      for (int i = 0; i < gSkySprite.height; i++)
       {
-         for (int i = 0; i < dim.x; i++)
+         while (mSky[i].size() < COLS)
          {
-            const char* line = sprite[i];
-            for (int j = 0; j < dim.y && j < COLS; j++)
-            {
-               //if (line[j] == '.') attron(COLOR_PAIR(8));
-               mvaddch(i+SCREEN_START, ypos+j, line[j]);
-               //if (line[j] == '.') attroff(COLOR_PAIR(8));
-            }
+            mSky[i].append(gSkySprite.rows[i], min<int>(gSkySprite.width, COLS - mSky[i].size()));
          }
-         ypos += dim.y;
+      }
+   }
+
+   void drawSky()
+   {
+      // the sky is a background, so whole rows are drawn to clear the band
+      for (int i = 0; i < mSky.size(); i++)
+      {
+         mvaddnstr(i+SCREEN_START, 0, mSky[i].c_str(), mSky[i].size());
       }
    }
 
@@ -235,7 +598,7 @@ public:
       mvprintw(1,0, "Score: %10d", mScore);
       mElapsedTime += dt;
 
-      drawSky(gDimSky, gSkySprite);  
+      drawSky();
       mTxt.update(dt, mElapsedTime);
       mTxt.processUserInput(c);
 
@@ -246,7 +609,7 @@ public:
       if (mBee.finished() && mBee.inMotion())
       {
          mBee.stop();
-         mBeeSpawn = mElapsedTime + MIN_TIME_OFFSET + rand() % VAR_TIME_OFFSET;
+         mBeeSpawn = mElapsedTime + MIN_TIME_OFFSET + gameRand() % VAR_TIME_OFFSET;
       }
 
       if (mElapsedTime > mBeeSpawn && !mBee.inMotion())
@@ -257,15 +620,32 @@ public:
          }
          else
          {
-            mBeeSpawn = mElapsedTime + MIN_TIME_OFFSET + rand() % VAR_TIME_OFFSET; //extension
+            mBeeSpawn = mElapsedTime + MIN_TIME_OFFSET + gameRand() % VAR_TIME_OFFSET; //extension
          }
       }
 
       wrefresh(stdscr);
    }
 
+   bool finished() { return mTxt.finished(); }
+   char expectedKey() { return mTxt.expectedKey(); }
+   int numOnScreen() { return mTxt.numOnScreen(); }
+   int numFailed() { return mTxt.numFailed(); }
+   int score() const { return mScore; }
+   float elapsedTime() const { return mElapsedTime; }
+
 private:
 
+   Vec2 textStart() const
+   {
+      return Vec2(LINES, ((int) COLS*0.5) - 19); // hard-coded for injust.txt
+   }
+
+   bool skyCollision(int x, int y) const
+   {
+      x -= SCREEN_START;
+      return x >= 0 && x < mSky.size() && y >= 0 && y < mSky[x].size() && mSky[x][y] != ' ';
+   }
 
    enum RainbowColors { RB_1 = 3, RB_2, RB_3, RB_4, RB_5, RB_6 };
    int mScore;
@@ -274,6 +654,10 @@ private:
    static constexpr int SCREEN_START = 3;
    static constexpr int VAR_TIME_OFFSET = 5;
    static constexpr float MIN_TIME_OFFSET = 2.0f;   
+   vector<string> mSky; // sky tiled to the screen width, also used for collisions
+   SCREEN* mScreen; // only set for the null renderer
+   FILE* mNullOut;
+   FILE* mNullIn;
 
    //----------------------------------------------
    // Scrolling text logic
@@ -287,6 +671,7 @@ private:
          mGame = g;
          mYcursorOffset = 0;
          mCurrent = 0;
+         mNumFailed = 0;
          mDt = 0;
          mVel = _vel;
          mStartpos = _startpos; 
@@ -297,8 +682,9 @@ private:
          char buffer[2056];
          strncpy(buffer, line.c_str(), 2056);
 
-         int x = mStartpos.x;
-         int y = mStartpos.y + rand() % 10 - 5;
+         // hidden words are relative to mStartpos until they spawn
+         int x = 0;
+         int y = gameRand() % 10 - 5;
          int num_spaces = 0;
          char* token = findword(buffer, ' ', num_spaces);
          while (token)
@@ -319,9 +705,33 @@ private:
       int top() // height of the topmost word
       {
          if (finished()) return LINES-1;
+         if (mState[mCurrent] == WS_HIDDEN) return mStartpos.x + mPos[mCurrent].x;
          return mPos[mCurrent].x;
       }
 
+      void spawn(int word_id)
+      {
+         mState[word_id] = WS_INIT;
+         mPos[word_id] = mPos[word_id] + mStartpos;
+      }
+
+      // moves the words on screen along with the start position and keeps
+      // them inside the screen
+      void relayout(const Vec2& startpos)
+      {
+         int shift = startpos.y - mStartpos.y;
+         mStartpos = startpos;
+         for (int k = mCurrent; k < mWords.size(); k++)
+         {
+            if (mState[k] == WS_HIDDEN) continue;
+
+            eraseWord(k);
+            int maxY = max(0, COLS - (int) mWords[k].size());
+            mPos[k].y = min(max(mPos[k].y + shift, 0), maxY);
+            mPos[k].x = min(mPos[k].x, LINES-1);
+         }
+      }
+
       bool finished()
       {
          return (mCurrent >= mWords.size()); // all done!
@@ -332,6 +742,28 @@ private:
          return mWords.size(); 
       }
 
+      char expectedKey() // next char to type, -1 if none
+      {
+         if (finished() || mState[mCurrent] == WS_HIDDEN) return -1;
+         if (mYcursorOffset >= mWords[mCurrent].size()) return -1;
+         return mWords[mCurrent][mYcursorOffset];
+      }
+
+      int numOnScreen() const // spawned words that are not typed yet
+      {
+         int count = 0;
+         for (int k = mCurrent; k < mWords.size(); k++)
+         {
+            if (mState[k] != WS_HIDDEN) count++;
+         }
+         return count;
+      }
+
+      int numFailed() const
+      {
+         return mNumFailed;
+      }
+
       void eraseWord(int word_id)
       {
          // erase old word position and update pos
@@ -387,10 +819,7 @@ private:
       {
          for (int i = 0; i < mWords[word_id].size(); i++)
          {
-            int x = mPos[word_id].x - TypingGame::SCREEN_START;
-            int y = mPos[word_id].y+i;
-            int y_tile = y % gDimSky.y;
-            if (x >= 0 && x < gDimSky.x && gSkySprite[x][y_tile] != ' ')
+            if (mGame->skyCollision(mPos[word_id].x, mPos[word_id].y+i))
             {
                return true;
             }
@@ -409,7 +838,7 @@ private:
          float advance = 0;
          if (mSpawn[mCurrent] > elapsedTime && mState[mCurrent] == WS_HIDDEN) // waiting, start it early
          {
-             mState[mCurrent] = WS_INIT;
+             spawn(mCurrent);
              advance = mSpawn[mCurrent] - elapsedTime;
          }         
 
@@ -423,7 +852,7 @@ private:
 
             if (mState[k] == WS_HIDDEN && elapsedTime > mSpawn[k])
             {
-               mState[k] = WS_INIT;
+               spawn(k);
             }
 
             if (mState[k] != WS_COMPLETE && mState[k] != WS_FAIL && mState[k] != WS_HIDDEN)
@@ -453,6 +882,7 @@ private:
                   int y = mPos[k].y;
                   mGame->createExplosion(Vec2(x,y),WS_ERROR);
                   mState[k] = WS_FAIL; 
+                  mNumFailed++;
                }       
             }
          }
@@ -460,6 +890,8 @@ private:
 
       void processUserInput(char c)
       {
+         if (mState[mCurrent] == WS_HIDDEN) return; // not on screen yet
+
          if (mWords[mCurrent][mYcursorOffset] == c) // correct 
          {
             mState[mCurrent] = WS_INPROGRESS;
@@ -521,7 +953,53 @@ private:
                }
             }
          }
-         move(mPos[mCurrent].x, mPos[mCurrent].y + mYcursorOffset); 
+         if (mState[mCurrent] != WS_HIDDEN)
+         {
+            move(mPos[mCurrent].x, mPos[mCurrent].y + mYcursorOffset); 
+         }
+      }
+
+      void save(SnapshotWriter& out) const
+      {
+         out.put(mVel);
+         out.put(mDt);
+         out.put(mCurrent);
+         out.put(mYcursorOffset);
+         out.put(mNumFailed);
+         out.put(mStartpos);
+         out.putAll(mWords);
+         out.putAll(mPos);
+         out.putAll(mSpawn);
+         out.putAll(mState);
+      }
+
+      void restore(SnapshotReader& in)
+      {
+         in.get(mVel);
+         in.get(mDt);
+         in.get(mCurrent);
+         in.get(mYcursorOffset);
+         in.get(mNumFailed);
+         in.get(mStartpos);
+         in.getAll(mWords);
+         in.getAll(mPos);
+         in.getAll(mSpawn);
+         in.getAll(mState);
+
+         int n = mWords.size();
+         if (mPos.size() != n || mSpawn.size() != n || mState.size() != n ||
+             mCurrent < 0 || mCurrent > n || mYcursorOffset < 0 || 
+             (mCurrent < n && mYcursorOffset > mWords[mCurrent].size()))
+         {
+            throw runtime_error("snapshot has inconsistent text");
+         }
+
+         mDim.resize(n);
+         for (int k = 0; k < n; k++)
+         {
+            if (mState[k] < WS_INIT || mState[k] > WS_HIDDEN) throw runtime_error("snapshot has bad word state");
+            mDim[k] = Vec2(1, mWords[k].size());
+         }
       }
 
    private:
@@ -535,6 +1013,7 @@ private:
       float mDt; // time since last update
       int mCurrent; // current text to type
       int mYcursorOffset; // y offset of cursor cursorpos;
+      int mNumFailed; // words that crashed before being typed
       Vec2 mStartpos; // position of first line of text
    } mTxt;
 
@@ -548,15 +1027,11 @@ private:
       void init()
       {
          mElapsedTime = 0;
-         mExplosionAnimation.push_back(gExplosion1);
-         mExplosionAnimation.push_back(gExplosion2);
-         mExplosionAnimation.push_back(gExplosion3);
-         mExplosionAnimation.push_back(gExplosion4);
       }
 
       void create(const Vec2& p, int c)
       {
-         mPos.push_back(p-gDimExplosion*0.5);
+         mPos.push_back(p-gExplosion.dim()*0.5);
          mStage.push_back(0);
          mColor.push_back(c);
       }
@@ -577,23 +1052,13 @@ private:
             int stage = mStage[e];
             int c = mColor[e];
             attron(COLOR_PAIR(c));	
-            for (int i = 0; i < gDimExplosion.x; i++)
-            {
-               int x = p.x+i;
-               if (x > LINES) continue;
-               for (int j = 0; j < gDimExplosion.y; j++)
-               {
-                  int y = p.y+j;
-                  if (y > COLS) continue;
-                  mvaddch(x, y, mExplosionAnimation[stage][i][j]);
-               }
-            }
+            gExplosion.draw(stage, p);
             attroff(COLOR_PAIR(c));	
             if (inc) mStage[e]++;
          }
    
          // remove finished explosions
-         while (mStage[0] >= mExplosionAnimation.size())
+         while (!mStage.empty() && mStage[0] >= gExplosion.numFrames)
          {
             mPos.pop_front();
             mStage.pop_front();
@@ -601,12 +1066,35 @@ private:
          }
       }
 
+      void save(SnapshotWriter& out) const
+      {
+         out.put(mElapsedTime);
+         out.putAll(mPos);
+         out.putAll(mStage);
+         out.putAll(mColor);
+      }
+
+      void restore(SnapshotReader& in)
+      {
+         in.get(mElapsedTime);
+         in.getAll(mPos);
+         in.getAll(mStage);
+         in.getAll(mColor);
+         if (mStage.size() != mPos.size() || mColor.size() != mPos.size())
+         {
+            throw runtime_error("snapshot has inconsistent explosions");
+         }
+         for (int e = 0; e < mStage.size(); e++)
+         {
+            if (mStage[e] < 0 || mStage[e] >= gExplosion.numFrames) throw runtime_error("snapshot has bad explosion");
+         }
+      }
+
    private:
       deque<Vec2> mPos;
       deque<int> mStage;
       deque<int> mColor;
       float mElapsedTime;
-      vector<const char**> mExplosionAnimation;
       static constexpr float RATE = 0.1;
    } mExplosions;
 
@@ -618,7 +1106,8 @@ private:
    public:
       void init(const Vec2& v, const Vec2& sp, int c)
       {
-         mFlairOffset = rand() % gNumFlair;
+         mFlairOffset = gameRand() % gNumFlair;
+         mDt = 0;
          mVel = v;
          mStartpos = sp;
          mPos = sp;
@@ -645,31 +1134,15 @@ private:
 
       bool finished()
       {
-         return ((mPos.x < -gDimBeeSprite.x || mPos.x > LINES-1) || 
-                 (mPos.y < -gDimBeeSprite.y || mPos.y > COLS-1));
+         return ((mPos.x < -gBeeSprite.height || mPos.x > LINES-1) || 
+                 (mPos.y < -gBeeSprite.width || mPos.y > COLS-1));
       }
 
       void draw(bool erase)
       {
          attron(COLOR_PAIR(mColor));
-         for (int i = 0; i < gDimBeeSprite.x; i++)
-         {
-            int x = mPos.x+i;
-            if (x < 0 || x > LINES) continue;
-            for (int j = 0; j < gDimBeeSprite.y; j++)
-            {
-               int y = mPos.y+j;
-               if (y < 0 || y > COLS) continue;
-               if (erase)
-               {
-                  mvaddch(x, y, ' ');
-               }
-               else
-               {
-                  mvaddch(x, y, gBeeSprite[i][j]);
-               }
-            }
-         }
+         if (erase) gBeeSprite.erase(mPos);
+         else gBeeSprite.draw(mPos);
          attroff(COLOR_PAIR(mColor));
 
          /*
@@ -699,7 +1172,30 @@ private:
 
       int trajectoryHeight() const
       {
-         return mStartpos.x+2+gDimBeeSprite.x;
+         return mStartpos.x+2+gBeeSprite.height;
+      }
+
+      void save(SnapshotWriter& out) const
+      {
+         out.put(mStartpos);
+         out.put(mPos);
+         out.put(mVel);
+         out.put(mFlairOffset);
+         out.put(mDt);
+         out.put(mColor);
+         out.put(mPause);
+      }
+
+      void restore(SnapshotReader& in)
+      {
+         in.get(mStartpos);
+         in.get(mPos);
+         in.get(mVel);
+         in.get(mFlairOffset);
+         in.get(mDt);
+         in.get(mColor);
+         in.get(mPause);
+         if (mFlairOffset < 0 || mFlairOffset >= gNumFlair) throw runtime_error("snapshot has bad bee");
       }
 
    private:
@@ -714,24 +1210,656 @@ private:
 
 };
 
+//---------------------------------
+// broadcast: stream the screen to spectators over a UNIX socket
+//---------------------------------
+// Every message starts with a 13 byte header, integers are little endian:
+//   u8 type ('K' keyframe or 'D' delta), u16 rows, u16 cols,
+//   u16 cursor row, u16 cursor col, u32 payload size
+// A keyframe payload is rows*cols cells. A delta payload is a list of runs:
+//   u16 row, u16 col, u16 count, then count cells
+// A cell is two bytes: the character, then the color pair in the low 4 bits
+// and 0x10 for bold.
+const int BROADCAST_HEADER_SIZE = 13;
+
+void putU16(string& out, int v)
+{
+   out += (char) (v & 0xff);
+   out += (char) ((v >> 8) & 0xff);
+}
+
+void putU32(string& out, uint32_t v)
+{
+   putU16(out, v & 0xffff);
+   putU16(out, v >> 16);
+}
+
+int getU16(const char* p)
+{
+   return (unsigned char) p[0] | ((unsigned char) p[1] << 8);
+}
+
+uint32_t getU32(const char* p)
+{
+   return getU16(p) | ((uint32_t) getU16(p+2) << 16);
+}
+
+class Broadcaster
+{
+public:
+   Broadcaster() : mListen(-1), mRows(0), mCols(0), mCursorY(-1), mCursorX(-1) {}
+
+   ~Broadcaster()
+   {
+      for (int i = 0; i < mSubscribers.size(); i++) close(mSubscribers[i].fd);
+      if (mListen >= 0)
+      {
+         close(mListen);
+         if (isSocket(mPath)) unlink(mPath.c_str());
+      }
+   }
+
+   bool listen(const string& path)
+   {
+      sockaddr_un addr;
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (path.size() >= sizeof(addr.sun_path)) return false;
+      strcpy(addr.sun_path, path.c_str());
+
+      struct stat st;
+      if (lstat(path.c_str(), &st) == 0)
+      {
+         if (!S_ISSOCK(st.st_mode)) throw runtime_error(path + ": path exists");
+         unlink(path.c_str()); // socket left over from an earlier run
+      }
+
+      mListen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+      if (mListen < 0) return false;
+      if (bind(mListen, (sockaddr*) &addr, sizeof(addr)) != 0 || ::listen(mListen, 16) != 0)
+      {
+         close(mListen);
+         mListen = -1;
+         return false;
+      }
+      mPath = path;
+      return true;
+   }
+
+   // call once per frame after the screen is drawn; never blocks
+   void publish()
+   {
+      accept();
+      if (mSubscribers.empty())
+      {
+         mRows = mCols = 0; // the next subscriber gets a keyframe anyway
+         return;
+      }
+
+      bool resized = (mRows != LINES || mCols != COLS);
+      mRows = LINES;
+      mCols = COLS;
+      mPrev.swap(mCells);
+      mCells.resize(mRows * mCols + 1); // winchnstr writes a 0 after the last row
+
+      // capturing moves the cursor, so read it first and put it back after
+      int cy, cx;
+      getyx(stdscr, cy, cx);
+      for (int i = 0; i < mRows; i++)
+      {
+         mvwinchnstr(stdscr, i, 0, &mCells[i * mCols], mCols);
+      }
+      move(cy, cx);
+      bool cursorMoved = (cy != mCursorY || cx != mCursorX);
+      mCursorY = cy;
+      mCursorX = cx;
+
+      // both messages are built at most once per frame and shared by all subscribers
+      shared_ptr<string> keyframe, delta;
+      for (int s = 0; s < mSubscribers.size(); s++)
+      {
+         Subscriber& sub = mSubscribers[s];
+         if (resized || sub.needsKeyframe)
+         {
+            if (!keyframe) keyframe = encodeKeyframe(cy, cx);
+            if (queue(sub, keyframe, true)) sub.needsKeyframe = false;
+         }
+         else
+         {
+            if (!delta) delta = encodeDelta(cy, cx);
+            if (delta->size() > BROADCAST_HEADER_SIZE || cursorMoved) queue(sub, delta, false);
+         }
+      }
+      flush();
+   }
+
+   int numSubscribers() const { return mSubscribers.size(); }
+
+private:
+   struct Subscriber
+   {
+      int fd;
+      deque<shared_ptr<string> > pending;
+      size_t sent; // bytes of pending.front() already sent
+      size_t bytes; // unsent bytes in pending
+      bool needsKeyframe;
+   };
+
+   static bool isSocket(const string& path)
+   {
+      struct stat st;
+      return lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode);
+   }
+
+   void accept()
+   {
+      if (mListen < 0) return;
+      int fd;
+      while ((fd = accept4(mListen, 0, 0, SOCK_NONBLOCK)) >= 0)
+      {
+         Subscriber sub;
+         sub.fd = fd;
+         sub.sent = 0;
+         sub.bytes = 0;
+         sub.needsKeyframe = true;
+         mSubscribers.push_back(sub);
+      }
+   }
+
+   // returns false if the message was dropped because the subscriber is too slow
+   bool queue(Subscriber& sub, const shared_ptr<string>& msg, bool isKeyframe)
+   {
+      if (sub.bytes + msg->size() > MAX_PENDING)
+      {
+         // drop what it has not started to read and resync it with a keyframe
+         while (sub.pending.size() > (sub.sent > 0 ? 1 : 0))
+         {
+            sub.bytes -= sub.pending.back()->size();
+            sub.pending.pop_back();
+         }
+         if (sub.sent > 0) sub.bytes = sub.pending.front()->size() - sub.sent;
+
+         // a keyframe replaces everything dropped, so it is always let in,
+         // even if it alone is larger than MAX_PENDING
+         if (!isKeyframe)
+         {
+            sub.needsKeyframe = true;
+            return false;
+         }
+      }
+      sub.pending.push_back(msg);
+      sub.bytes += msg->size();
+      return true;
+   }
+
+   void flush()
+   {
+      for (int s = 0; s < mSubscribers.size(); s++)
+      {
+         Subscriber& sub = mSubscribers[s];
+         bool closed = false;
+         while (!sub.pending.empty())
+         {
+            const string& msg = *sub.pending.front();
+            ssize_t n = send(sub.fd, msg.data() + sub.sent, msg.size() - sub.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0)
+            {
+               closed = (errno != EAGAIN && errno != EWOULDBLOCK);
+               break;
+            }
+            sub.sent += n;
+            sub.bytes -= n;
+            if (sub.sent < msg.size()) break; // socket buffer is full
+            sub.pending.pop_front();
+            sub.sent = 0;
+         }
+
+         if (closed)
+         {
+            close(sub.fd);
+            mSubscribers.erase(mSubscribers.begin() + s);
+            s--;
+         }
+      }
+   }
+
+   shared_ptr<string> encodeHeader(char type, int cy, int cx)
+   {
+      shared_ptr<string> msg(new string);
+      *msg += type;
+      putU16(*msg, mRows);
+      putU16(*msg, mCols);
+      putU16(*msg, cy);
+      putU16(*msg, cx);
+      putU32(*msg, 0); // payload size, filled in by finish
+      return msg;
+   }
+
+   void finish(string& msg)
+   {
+      string size;
+      putU32(size, msg.size() - BROADCAST_HEADER_SIZE);
+      msg.replace(BROADCAST_HEADER_SIZE - 4, 4, size);
+   }
+
+   void putCell(string& out, chtype c)
+   {
+      out += (char) (c & A_CHARTEXT);
+      out += (char) ((PAIR_NUMBER(c & A_COLOR) & 0x0f) | ((c & A_BOLD) ? 0x10 : 0));
+   }
+
+   shared_ptr<string> encodeKeyframe(int cy, int cx)
+   {
+      shared_ptr<string> msg = encodeHeader('K', cy, cx);
+      int numCells = mRows * mCols;
+      msg->reserve(BROADCAST_HEADER_SIZE + numCells * 2);
+      for (int i = 0; i < numCells; i++) putCell(*msg, mCells[i]);
+      finish(*msg);
+      return msg;
+   }
+
+   shared_ptr<string> encodeDelta(int cy, int cx)
+   {
+      shared_ptr<string> msg = encodeHeader('D', cy, cx);
+      for (int i = 0; i < mRows; i++)
+      {
+         const chtype* cur = &mCells[i * mCols];
+         const chtype* prev = &mPrev[i * mCols];
+         int j = 0;
+         while (j < mCols)
+         {
+            if (cur[j] == prev[j]) { j++; continue; }
+
+            // a run also covers short gaps of unchanged cells, which is
+            // cheaper than the 6 byte header of a new run
+            int start = j, end = j + 1;
+            for (j = end; j < mCols && j - end < RUN_GAP; j++)
+            {
+               if (cur[j] != prev[j]) end = j + 1;
+            }
+            putU16(*msg, i);
+            putU16(*msg, start);
+            putU16(*msg, end - start);
+            for (int k = start; k < end; k++) putCell(*msg, cur[k]);
+            j = end;
+         }
+      }
+      finish(*msg);
+      return msg;
+   }
+
+   int mListen;
+   string mPath;
+   vector<Subscriber> mSubscribers;
+   vector<chtype> mCells; // screen at this frame
+   vector<chtype> mPrev; // screen sent at the last frame
+   int mRows;
+   int mCols;
+   int mCursorY; // cursor sent at the last frame
+   int mCursorX;
+   static constexpr size_t MAX_PENDING = 256 * 1024; // per subscriber
+   static constexpr int RUN_GAP = 3;
+};
+
+// Spectator: shows the game broadcast on the socket at path until ESC or the
+// game ends.
+int watchBroadcast(const string& path)
+{
+   sockaddr_un addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (fd < 0 || connect(fd, (sockaddr*) &addr, sizeof(addr)) != 0)
+   {
+      perror("connect");
+      if (fd >= 0) close(fd);
+      return 1;
+   }
+
+   initscr();
+   noecho();
+   cbreak();
+   nodelay(stdscr, TRUE);
+   TypingGame::initColors();
+
+   string buf;
+   char chunk[65536];
+   bool running = true;
+   while (running && getch() != 27)
+   {
+      pollfd pfd = {fd, POLLIN, 0};
+      if (poll(&pfd, 1, 50) <= 0) continue;
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n <= 0) break;
+      buf.append(chunk, n);
+
+      size_t pos = 0;
+      while (buf.size() - pos >= BROADCAST_HEADER_SIZE)
+      {
+         const char* h = buf.data() + pos;
+         uint32_t size = getU32(h + 9);
+         if (buf.size() - pos < BROADCAST_HEADER_SIZE + size) break;
+
+         char type = h[0];
+         int rows = getU16(h + 1), cols = getU16(h + 3);
+         const char* p = h + BROADCAST_HEADER_SIZE;
+         const char* end = p + size;
+         if (type == 'K')
+         {
+            erase();
+            for (int i = 0; i < rows; i++)
+            {
+               for (int j = 0; j < cols && p + 2 <= end; j++, p += 2)
+               {
+                  int attr = COLOR_PAIR(p[1] & 0x0f) | ((p[1] & 0x10) ? A_BOLD : 0);
+                  mvaddch(i, j, (unsigned char) p[0] | attr);
+               }
+            }
+         }
+         else if (type == 'D')
+         {
+            while (p + 6 <= end)
+            {
+               int row = getU16(p), col = getU16(p + 2), count = getU16(p + 4);
+               p += 6;
+               for (int k = 0; k < count && p + 2 <= end; k++, p += 2)
+               {
+                  int attr = COLOR_PAIR(p[1] & 0x0f) | ((p[1] & 0x10) ? A_BOLD : 0);
+                  mvaddch(row, col + k, (unsigned char) p[0] | attr);
+               }
+            }
+         }
+         else
+         {
+            running = false; // not a broadcast
+            break;
+         }
+         move(getU16(h + 5), getU16(h + 7));
+         pos += BROADCAST_HEADER_SIZE + size;
+      }
+      buf.erase(0, pos);
+      refresh();
+   }
+
+   endwin();
+   close(fd);
+   return 0;
+}
+
+//---------------------------------
+// bots: synthetic players for stress testing
+//---------------------------------
+struct BotConfig
+{
+   int numBots = 1;
+   float cps = 8; // keystrokes per second
+   float errorRate = 0.05f; // chance a keystroke is wrong
+   float burstiness = 0; // 0 = steady typing, 1 = all keys in bursts followed by pauses
+   float fps = 60; // simulated frame rate
+   float duration = 120; // simulated seconds per bot
+   bool screen = false; // bot 0 draws to the terminal, the rest use the null renderer
+};
+
+struct BotStats
+{
+   int id;
+   long frames;
+   long keys;
+   long errors;
+   int peakOnScreen;
+   int failed;
+   int score;
+   float simTime;
+   float wallTime;
+};
+
+class TypingBot
+{
+public:
+   TypingBot(const BotConfig& cfg) : mCfg(cfg), mWait(0), mBurstPos(0) {}
+
+   // returns the key typed during this frame or -1
+   char nextKey(float dt, char expected, bool& error)
+   {
+      error = false;
+      mWait -= dt;
+      if (mWait > 0 || expected == -1) return -1;
+
+      // keys within a burst are faster and the last key is followed by a longer
+      // pause, so the average rate stays at cps
+      float interval = 1.0f / mCfg.cps;
+      mBurstPos = (mBurstPos+1) % BURST_LENGTH;
+      if (mBurstPos != 0) mWait += interval * (1 - mCfg.burstiness);
+      else mWait += interval * (1 + mCfg.burstiness * (BURST_LENGTH-1));
+      if (mWait < 0) mWait = 0; // can't type faster than one key per frame
+
+      if (rand() < mCfg.errorRate * RAND_MAX)
+      {
+         error = true;
+         return expected == '#' ? '@' : '#';
+      }
+      return expected;
+   }
+
+private:
+   BotConfig mCfg;
+   float mWait; // time until the next key
+   int mBurstPos;
+   static constexpr int BURST_LENGTH = 5;
+};
+
+float secondsSince(const timespec& then)
+{
+   timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return float(now.tv_sec - then.tv_sec + (now.tv_nsec - then.tv_nsec)/1000000000.0);
+}
+
+BotStats runBot(const BotConfig& cfg, bool screen)
+{
+   BotStats stats;
+   memset(&stats, 0, sizeof(stats));
+
+   timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+
+   TypingGame game(!screen);
+   TypingBot bot(cfg);
+   float dt = 1.0f / cfg.fps;
+   while (game.elapsedTime() < cfg.duration)
+   {
+      if (game.finished()) // keep the game busy by starting the text again
+      {
+         // an empty file adds no words, so the game would stay finished
+         if (!game.loadFile("injust.txt", game.elapsedTime()) || game.finished())
+         {
+            game.addLine("The quick brown fox jumps over the lazy dog.", game.elapsedTime());
+         }
+      }
+      if (screen)
+      {
+         int key = getch();
+         if (key == 27) break;
+         if (key == KEY_RESIZE) game.resize();
+      }
+
+      bool error;
+      char c = bot.nextKey(dt, game.expectedKey(), error);
+      game.updateAndDraw(dt, c);
+
+      stats.frames++;
+      if (c != -1) stats.keys++;
+      if (error) stats.errors++;
+      stats.peakOnScreen = max(stats.peakOnScreen, game.numOnScreen());
+   }
+
+   stats.failed = game.numFailed();
+   stats.score = game.score();
+   stats.simTime = game.elapsedTime();
+   stats.wallTime = secondsSince(start);
+   return stats;
+}
+
+// Runs each bot in its own process so the bots use separate cores and
+// separate curses screens. Results come back over a pipe.
+int runBots(const BotConfig& cfg)
+{
+   int fd[2];
+   if (pipe(fd) != 0) 
+   {
+      perror("pipe");
+      return 1;
+   }
+
+   for (int i = 0; i < cfg.numBots; i++)
+   {
+      pid_t pid = fork();
+      if (pid < 0)
+      {
+         perror("fork");
+         break;
+      }
+      if (pid == 0)
+      {
+         close(fd[0]);
+         srand(time(0) + i);
+         gRandState = rand();
+         int status = 0;
+         try
+         {
+            BotStats stats = runBot(cfg, cfg.screen && i == 0);
+            stats.id = i;
+            if (write(fd[1], &stats, sizeof(stats)) != sizeof(stats)) status = 1;
+         }
+         catch (exception& e)
+         {
+            cerr << "bot " << i << ": " << e.what() << endl;
+            status = 1;
+         }
+         close(fd[1]);
+         _exit(status);
+      }
+   }
+   close(fd[1]);
+
+   BotStats stats;
+   vector<BotStats> results;
+   while (read(fd[0], &stats, sizeof(stats)) == sizeof(stats))
+   {
+      results.push_back(stats);
+   }
+   close(fd[0]);
+   while (wait(0) > 0) {}
+
+   if (results.empty())
+   {
+      cout << "No bot finished." << endl;
+      return 1;
+   }
+
+   double keys = 0, frames = 0;
+   long errors = 0, failed = 0;
+   int peak = 0;
+   for (int i = 0; i < results.size(); i++)
+   {
+      const BotStats& s = results[i];
+      keys += s.keys / s.wallTime;
+      frames += s.frames / s.wallTime;
+      errors += s.errors;
+      failed += s.failed;
+      peak = max(peak, s.peakOnScreen);
+      printf("bot %2d: %8.0f keys/s %10.0f frames/s  sim %6.1fs  score %6d  failed %4d  peak on screen %3d\n",
+         s.id, s.keys / s.wallTime, s.frames / s.wallTime, s.simTime, s.score, s.failed, s.peakOnScreen);
+   }
+
+   long cores = sysconf(_SC_NPROCESSORS_ONLN);
+   int busy = min((long) results.size(), max(cores, 1L));
+   printf("total : %8.0f keys/s %10.0f frames/s (%d bots, %ld cores)\n", keys, frames, (int) results.size(), cores);
+   printf("core  : %8.0f keys/s %10.0f frames/s\n", keys / busy, frames / busy);
+   printf("typing errors %ld, failed words %ld, peak words on screen %d\n", errors, failed, peak);
+   return results.size() == cfg.numBots ? 0 : 1;
+}
+
+const float SNAPSHOT_INTERVAL = 5; // seconds between automatic snapshots
+
 int main(int argc, char **argv)
 {
+   BotConfig botCfg;
+   bool bots = false;
+   string snapshot; // resume from and save to this file
+   string broadcast; // socket path spectators connect to
+   for (int i = 1; i < argc; i++)
+   {
+      string arg = argv[i];
+      bool hasValue = i+1 < argc;
+      if (arg == "--bots" && hasValue) { bots = true; botCfg.numBots = atoi(argv[++i]); }
+      else if (arg == "--cps" && hasValue) botCfg.cps = atof(argv[++i]);
+      else if (arg == "--errors" && hasValue) botCfg.errorRate = atof(argv[++i]);
+      else if (arg == "--burst" && hasValue) botCfg.burstiness = atof(argv[++i]);
+      else if (arg == "--fps" && hasValue) botCfg.fps = atof(argv[++i]);
+      else if (arg == "--duration" && hasValue) botCfg.duration = atof(argv[++i]);
+      else if (arg == "--screen") botCfg.screen = true;
+      else if (arg == "--snapshot" && hasValue) snapshot = argv[++i];
+      else if (arg == "--broadcast" && hasValue) broadcast = argv[++i];
+      else if (arg == "--watch" && hasValue) return watchBroadcast(argv[++i]);
+      else
+      {
+         cout << "usage: " << argv[0] << " [--snapshot FILE] [--broadcast SOCKET] [--watch SOCKET] [--bots N [--cps F] [--errors F] [--burst F] [--fps F] [--duration S] [--screen]]" << endl;
+         return 1;
+      }
+   }
+
+   if (bots)
+   {
+      if (botCfg.numBots < 1 || botCfg.cps <= 0 || botCfg.fps <= 0)
+      {
+         cout << "--bots, --cps and --fps must be positive" << endl;
+         return 1;
+      }
+      botCfg.burstiness = min(max(botCfg.burstiness, 0.0f), 1.0f);
+      return runBots(botCfg);
+   }
+
    try
    {
       float elapsedTime = 0; // todo: move to game class
+      float savedTime = 0;
       struct timespec then, now;
       clock_gettime(CLOCK_MONOTONIC, &then);
 
       TypingGame game;
-      if (!game.loadFile("injust.txt")) // load default text
+      Broadcaster broadcaster;
+      if (!broadcast.empty() && !broadcaster.listen(broadcast))
       {
-         game.addLine("The quick brown fox jumps over the lazy dog.", 0);
-      }      
+         throw runtime_error("cannot listen on " + broadcast);
+      }
+      if (snapshot.empty() || !game.loadSnapshot(snapshot))
+      {
+         if (!game.loadFile("injust.txt")) // load default text
+         {
+            game.addLine("The quick brown fox jumps over the lazy dog.", 0);
+         }      
+      }
 
       while (true)
       {
-         char c = getch();
-         if (c == 27) break;
+         int key = getch();
+         if (key == 27) 
+         {
+            if (!snapshot.empty())
+            {
+               if (game.finished()) unlink(snapshot.c_str()); // start over next time
+               else game.saveSnapshot(snapshot);
+            }
+            break;
+         }
+         if (key == KEY_RESIZE)
+         {
+            game.resize();
+            key = -1;
+         }
+         char c = key;
 
          clock_gettime(CLOCK_MONOTONIC, &now);
          float dt = float(now.tv_sec - then.tv_sec + (now.tv_nsec - then.tv_nsec)/1000000000.0);
@@ -744,6 +1872,12 @@ int main(int argc, char **argv)
          //mvaddstr(1,0,buff);
 
          game.updateAndDraw(dt, c);
+         broadcaster.publish();
+         if (!snapshot.empty() && elapsedTime - savedTime > SNAPSHOT_INTERVAL) // for crash recovery
+         {
+            game.saveSnapshot(snapshot);
+            savedTime = elapsedTime;
+         }
 #ifdef CYGWIN
          Sleep(100);
 #else